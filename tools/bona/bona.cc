@@ -2,6 +2,7 @@
 #include <bela/parseargv.hpp>
 #include <bela/path.hpp>
 #include <hazel/fs.hpp>
+#include <hazel/cache.hpp>
 #include "bona.hpp"
 #include "writer.hpp"
 #include "resource.h"
@@ -11,6 +12,8 @@
 namespace bona {
 bool IsDebugMode = false;
 bool IsFullMode = false;
+bool IsDeepMode = false;
+hazel::Cache *ClassificationCache = nullptr;
 bool AnalysisFile(std::wstring_view file, nlohmann::json *j) {
   bela::error_code ec;
   auto absPath = bela::FullPath(file);
@@ -29,7 +32,8 @@ bool AnalysisFile(std::wstring_view file, nlohmann::json *j) {
     return false;
   }
   hazel::hazel_result hr;
-  if (!hazel::LookupFile(*fd, hr, ec)) {
+  if (!(ClassificationCache != nullptr ? hazel::LookupFile(*ClassificationCache, *fd, hr, ec)
+                                       : hazel::LookupFile(*fd, hr, ec))) {
     AppenError(j, file, ec);
     bela::FPrintF(stderr, L"Lookup file %s error: %s\n", file, ec.message);
     return false;
@@ -84,14 +88,62 @@ bool AnalysisFile(std::wstring_view file, nlohmann::json *j) {
 
 } // namespace bona
 
+enum cache_command : int {
+  CacheNone,
+  CacheInvalidate = 1001,
+  CacheCompact,
+  CacheClear,
+};
+
 struct options {
   std::vector<std::wstring_view> files;
+  std::wstring_view cacheFile;
   int AnalysisResultToJson();
   int AnalysisResultToText();
+  int CacheCommand(hazel::Cache &cache);
   bool formatToJson{false};
   bool fullMode{false};
+  cache_command command{CacheNone};
 };
 
+int options::CacheCommand(hazel::Cache &cache) {
+  bela::error_code ec;
+  switch (command) {
+  case CacheInvalidate: {
+    int rc = 0;
+    for (const auto file : files) {
+      auto fd = bela::io::NewFile(file, ec);
+      hazel::file_identity fi;
+      if (!fd || !hazel::LookupIdentity(fd->NativeFD(), fi, ec)) {
+        bela::FPrintF(stderr, L"Invalidate %s error: %s\n", file, ec.message);
+        rc = 1;
+        continue;
+      }
+      bela::FPrintF(stdout, L"%s: %d verdicts dropped\n", file, cache.Invalidate(fi));
+    }
+    return rc;
+  }
+  case CacheCompact:
+    if (!cache.Compact(ec)) {
+      bela::FPrintF(stderr, L"Compact cache %s error: %s\n", cacheFile, ec.message);
+      return 1;
+    }
+    break;
+  case CacheClear:
+    if (!cache.Clear(ec)) {
+      bela::FPrintF(stderr, L"Clear cache %s error: %s\n", cacheFile, ec.message);
+      return 1;
+    }
+    break;
+  default:
+    break;
+  }
+  auto st = cache.Stats();
+  bela::FPrintF(stdout, L"%s: %d verdicts, %d dead, %d/%d slots, heap %d/%d bytes\n", cacheFile, st.entries, st.dead,
+                st.entries + st.dead, st.capacity, st.heapUsed, st.heapSize);
+  return 0;
+}
+
 int options::AnalysisResultToJson() {
   nlohmann::json j;
   for (const auto file : files) {
@@ -123,7 +175,13 @@ Usage: bona [option]... [file]...
   -v|--version     Show version number and quit
   -V|--verbose     Make the operation more talkative
   -f|--full        Full mode, view more detailed information of the file.
+  -d|--deep        Deep mode, list archive entries with the type of their content.
   -j|--json        Format and output file information into JSON.
+  -c|--cache       Classification cache file, unchanged files are not sniffed again.
+  --cache-invalidate
+                   Drop the cached verdicts of the listed files.
+  --cache-compact  Rewrite the cache without dropped verdicts, growing it when needed.
+  --cache-clear    Drop every cached verdict.
 
 )";
   bela::terminal::WriteAuto(stderr, usage);
@@ -141,7 +199,12 @@ bool ParseArgv(int argc, wchar_t **argv, options &opt) {
       .Add(L"version", bela::no_argument, 'v')
       .Add(L"verbose", bela::no_argument, 'V')
       .Add(L"json", bela::no_argument, 'j')
-      .Add(L"full", bela::no_argument, 'f'); // Full mode
+      .Add(L"full", bela::no_argument, 'f') // Full mode
+      .Add(L"deep", bela::no_argument, 'd') // Sniff the content of archive entries
+      .Add(L"cache", bela::required_argument, 'c')
+      .Add(L"cache-invalidate", bela::no_argument, CacheInvalidate)
+      .Add(L"cache-compact", bela::no_argument, CacheCompact)
+      .Add(L"cache-clear", bela::no_argument, CacheClear);
   bela::error_code ec;
   auto result = pa.Execute(
       [&](int val, const wchar_t *oa, const wchar_t *raw) {
@@ -161,6 +224,17 @@ bool ParseArgv(int argc, wchar_t **argv, options &opt) {
         case 'f':
           bona::IsFullMode = true;
           break;
+        case 'd':
+          bona::IsDeepMode = true;
+          break;
+        case 'c':
+          opt.cacheFile = oa;
+          break;
+        case CacheInvalidate:
+        case CacheCompact:
+        case CacheClear:
+          opt.command = static_cast<cache_command>(val);
+          break;
         default:
           break;
         }
@@ -172,7 +246,11 @@ bool ParseArgv(int argc, wchar_t **argv, options &opt) {
     return false;
   }
   opt.files = pa.UnresolvedArgs();
-  if (opt.files.empty()) {
+  if (opt.command != CacheNone && opt.cacheFile.empty()) {
+    bela::FPrintF(stderr, L"bona: cache commands need --cache\n");
+    return false;
+  }
+  if (opt.files.empty() && opt.command != CacheCompact && opt.command != CacheClear) {
     bela::FPrintF(stderr, L"bv: missing input file\n");
     return false;
   }
@@ -184,5 +262,17 @@ int wmain(int argc, wchar_t **argv) {
   if (!ParseArgv(argc, argv, opt)) {
     return 1;
   }
+  hazel::Cache cache;
+  if (!opt.cacheFile.empty()) {
+    bela::error_code ec;
+    if (!cache.Open(opt.cacheFile, ec)) {
+      bela::FPrintF(stderr, L"Open cache %s error: %s\n", opt.cacheFile, ec.message);
+      return 1;
+    }
+    if (opt.command != CacheNone) {
+      return opt.CacheCommand(cache);
+    }
+    bona::ClassificationCache = &cache;
+  }
   return opt.formatToJson ? opt.AnalysisResultToJson() : opt.AnalysisResultToText();
 }
\ No newline at end of file
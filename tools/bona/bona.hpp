@@ -8,6 +8,7 @@
 namespace bona {
 extern bool IsDebugMode;
 extern bool IsFullMode;
+extern bool IsDeepMode;
 // DbgPrint added newline
 template <typename... Args> bela::ssize_t DbgPrint(const wchar_t *fmt, const Args &...args) {
   if (!IsDebugMode) {
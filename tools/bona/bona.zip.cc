@@ -1,4 +1,5 @@
 ///
+#include <hazel/hazel.hpp>
 #include <hazel/zip.hpp>
 #include "bona.hpp"
 #include "writer.hpp"
@@ -75,9 +76,60 @@ void ZipAssginMethods(const hazel::zip::Reader &r, Writer &w) {
   w.Write(L"Method", ms);
 }
 
-bool AssginFiles(const hazel::zip::Reader &r, nlohmann::json *j) {
+// entry_content: type of an entry by the start of its data, the description is a static string
+struct entry_content {
+  hazel::types::hazel_types_t type{hazel::types::none};
+  std::wstring_view description;
+  bela::error_code ec;
+  bool sniffed{false};
+};
+
+constexpr size_t sniffPrefixSize = 4096;
+constexpr uint64_t sniffMemoryLimit = 64 * 1024 * 1024;
+
+// SniffEntries decompresses the first 4 KiB of every entry with ReadPrefixes and looks them up like a file prefix. The
+// workers read through handles of their own, a decoder gets at most 64 MiB, an entry that needs more shows the error.
+std::vector<entry_content> SniffEntries(const hazel::zip::Reader &r) {
+  std::vector<entry_content> contents(r.Files().size());
+  bela::error_code ec;
+  r.ReadPrefixes(
+      sniffPrefixSize, 0, sniffMemoryLimit,
+      [&](size_t index, std::span<const uint8_t> prefix, const bela::error_code &pec) {
+        auto &c = contents[index];
+        if (pec) {
+          c.ec = pec;
+          return;
+        }
+        uint8_t storage[16384];
+        hazel::hazel_arena arena(storage);
+        hazel::hazel_record record(arena, hazel::lookup_mode::type_only);
+        bela::error_code lec;
+        hazel::LookupBytes(bela::bytes_view(prefix.data(), prefix.size()), record, lec);
+        c.type = record.type();
+        c.description = record.description();
+        c.sniffed = true;
+      },
+      ec);
+  return contents;
+}
+
+std::wstring ContentText(const entry_content &c) {
+  if (c.ec) {
+    return bela::StringCat(L"error: ", c.ec.message);
+  }
+  if (!c.sniffed) {
+    return L"-";
+  }
+  if (c.description.empty()) {
+    return hazel::LookupMIME(c.type);
+  }
+  return std::wstring(c.description);
+}
+
+bool AssginFiles(const hazel::zip::Reader &r, const std::vector<entry_content> &contents, nlohmann::json *j) {
   auto fv = nlohmann::json::array();
-  for (const auto &file : r.Files()) {
+  for (size_t i = 0; i < r.Files().size(); i++) {
+    const auto &file = r.Files()[i];
     nlohmann::json item{
         {"name", file.name},
         {"method", file.method},
@@ -102,6 +154,12 @@ bool AssginFiles(const hazel::zip::Reader &r, nlohmann::json *j) {
     if (!file.comment.empty()) {
       item["comment"] = file.comment;
     }
+    if (i < contents.size() && contents[i].ec) {
+      item["content_error"] = bela::encode_into<wchar_t, char>(contents[i].ec.message);
+    } else if (i < contents.size() && contents[i].sniffed) {
+      item["content"] = bela::encode_into<wchar_t, char>(ContentText(contents[i]));
+      item["content_mime"] = bela::encode_into<wchar_t, char>(hazel::LookupMIME(contents[i].type));
+    }
     fv.emplace_back(std::move(item));
   }
   j->emplace("files", std::move(fv));
@@ -123,24 +181,34 @@ bool AnalysisZIP(bela::io::FD &fd, Writer &w, int64_t offset) {
   if (!r.Comment().empty()) {
     w.Write(L"Comments", r.Comment());
   }
-  if (!IsFullMode) {
+  if (!IsFullMode && !IsDeepMode) {
     ZipAssginMethods(r, w);
     return true;
   }
+  // deep mode lists the entries with the type of their content
+  std::vector<entry_content> contents;
+  if (IsDeepMode) {
+    contents = SniffEntries(r);
+  }
   if (auto j = w.Raw(); j != nullptr) {
-    AssginFiles(r, j);
+    AssginFiles(r, contents, j);
     return true;
   }
   // TODO fix zip ls
-  for (const auto &file : r.Files()) {
+  for (size_t i = 0; i < r.Files().size(); i++) {
+    const auto &file = r.Files()[i];
+    std::wstring content;
+    if (IsDeepMode) {
+      content = bela::StringCat(ContentText(contents[i]), L"\t");
+    }
     // good UTF-8
     if (file.IsFileNameUTF8()) {
-      bela::FPrintF(stdout, L"%s\t%s\t%d\t%s\t%s\n", hazel::zip::String(file.mode), hazel::zip::Method(file.method),
-                    file.uncompressed_size, bela::FormatTime(file.time), file.name);
+      bela::FPrintF(stdout, L"%s\t%s\t%d\t%s\t%s%s\n", hazel::zip::String(file.mode), hazel::zip::Method(file.method),
+                    file.uncompressed_size, bela::FormatTime(file.time), content, file.name);
       continue;
     }
-    bela::FPrintF(stdout, L"%s\t%s\t%d\t%s\t%s(*)\n", hazel::zip::String(file.mode), hazel::zip::Method(file.method),
-                  file.uncompressed_size, bela::FormatTime(file.time), FileNameRecoding(file.name));
+    bela::FPrintF(stdout, L"%s\t%s\t%d\t%s\t%s%s(*)\n", hazel::zip::String(file.mode), hazel::zip::Method(file.method),
+                  file.uncompressed_size, bela::FormatTime(file.time), content, FileNameRecoding(file.name));
   }
   return true;
 }
@@ -4,164 +4,15 @@
 #include <cstdio>
 #include <cstring>
 #include <clocale>
-#include <algorithm>
 #include <wchar.h>
+#include <io.h>
+#include <fcntl.h>
 #include <bela/terminal.hpp>
 #include <bela/base.hpp>
 #include <bela/numbers.hpp>
 #include <bela/parseargv.hpp>
 #include <belautilsversion.h>
-
-static const constexpr char hex[] = "0123456789abcdef";
-static int color(int b) {
-  constexpr unsigned char CN = 0x90; /* null    */
-  constexpr unsigned char CS = 0x92; /* space   */
-  constexpr unsigned char CP = 0x96; /* print   */
-  constexpr unsigned char CC = 0x95; /* control */
-  constexpr unsigned char CH = 0x93; /* high    */
-  static constexpr const unsigned char table[] = {
-      CN, CC, CC, CC, CC, CC, CC, CC, CC, CC, CS, CS, CS, CS, CC, CC, CC, CC, CC, CC, CC, CC, CC, CC, CC, CC,
-      CC, CC, CC, CC, CC, CC, CS, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP,
-      CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP,
-      CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP,
-      CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CP, CC, CH, CH,
-      CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH,
-      CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH,
-      CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH,
-      CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH,
-      CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH, CH};
-  return table[b];
-}
-
-static int display(int b) {
-  static constexpr const char table[] = {
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25,
-      0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
-      0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b,
-      0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e,
-      0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71,
-      0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
-  };
-  return table[b];
-}
-
-static void process_color(FILE *in, FILE *out, int64_t len) {
-  size_t i, n;
-  unsigned long offset = 0;
-  unsigned char input[16] = {0};
-  constexpr const uint64_t inputlen = sizeof(input);
-  char colortemplate[] = "00000000  "
-                         "\33[XXm## \33[XXm## \33[XXm## \33[XXm## "
-                         "\33[XXm## \33[XXm## \33[XXm## \33[XXm##  "
-                         "\33[XXm## \33[XXm## \33[XXm## \33[XXm## "
-                         "\33[XXm## \33[XXm## \33[XXm## \33[XXm##  "
-                         "\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm."
-                         "\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm.\33[XXm."
-                         "\33[0m\n";
-  static const int slots[] = {/* ANSI-color, hex, ANSI-color, ASCII */
-                              12,  15,  142, 145, 20,  23,  148, 151, 28,  31,  154, 157, 36,  39,  160, 163,
-                              44,  47,  166, 169, 52,  55,  172, 175, 60,  63,  178, 181, 68,  71,  184, 187,
-                              77,  80,  190, 193, 85,  88,  196, 199, 93,  96,  202, 205, 101, 104, 208, 211,
-                              109, 112, 214, 217, 117, 120, 220, 223, 125, 128, 226, 229, 133, 136, 232, 235};
-  uint64_t maxlen = len > 0 ? len : UINT64_MAX;
-
-  do {
-    auto rn = (std::min)(maxlen, inputlen);
-    n = fread(input, 1, (int)rn, in);
-    maxlen -= n;
-    /* Write the offset */
-    for (i = 0; i < 8; i++) {
-      colortemplate[i] = hex[(offset >> (28 - i * 4)) & 15];
-    }
-
-    /* Fill out the colortemplate */
-    for (i = 0; i < 16; i++) {
-      /* Use a fixed loop count instead of "n" to encourage loop
-       * unrolling by the compiler. Empty bytes will be erased
-       * later.
-       */
-      int v = input[i];
-      int c = color(v);
-      colortemplate[slots[i * 4 + 0] + 0] = hex[c >> 4];
-      colortemplate[slots[i * 4 + 0] + 1] = hex[c & 15];
-      colortemplate[slots[i * 4 + 1] + 0] = hex[v >> 4];
-      colortemplate[slots[i * 4 + 1] + 1] = hex[v & 15];
-      colortemplate[slots[i * 4 + 2] + 0] = hex[c >> 4];
-      colortemplate[slots[i * 4 + 2] + 1] = hex[c & 15];
-      colortemplate[slots[i * 4 + 3] + 0] = display(v);
-    }
-
-    /* Erase any trailing bytes */
-    for (i = n; i < 16; i++) {
-      /* This loop is only used once: the last line of output. The
-       * branch predictor will quickly learn that it's never taken.
-       */
-      colortemplate[slots[i * 4 + 0] + 0] = '0';
-      colortemplate[slots[i * 4 + 0] + 1] = '0';
-      colortemplate[slots[i * 4 + 1] + 0] = ' ';
-      colortemplate[slots[i * 4 + 1] + 1] = ' ';
-      colortemplate[slots[i * 4 + 2] + 0] = '0';
-      colortemplate[slots[i * 4 + 2] + 1] = '0';
-      colortemplate[slots[i * 4 + 3] + 0] = ' ';
-    }
-
-    if (!fwrite(colortemplate, sizeof(colortemplate) - 1, 1, out)) {
-      break; /* Output error */
-    }
-    offset += 16;
-  } while (n == 16 && maxlen > 0);
-}
-
-static void process_plain(FILE *in, FILE *out, int64_t len) {
-  size_t i, n;
-  unsigned long offset = 0;
-  unsigned char input[16] = {0};
-  constexpr const uint64_t inputlen = sizeof(input);
-  char colortemplate[] = "00000000  ## ## ## ## ## ## ## ##  ## ## ## ## ## ## ## ##  "
-                         "................\n";
-  static const int slots[] = {10, 60, 13, 61, 16, 62, 19, 63, 22, 64, 25, 65, 28, 66, 31, 67,
-                              35, 68, 38, 69, 41, 70, 44, 71, 47, 72, 50, 73, 53, 74, 56, 75};
-
-  uint64_t maxlen = len > 0 ? len : UINT64_MAX;
-  do {
-    auto rn = (std::min)(maxlen, inputlen);
-    n = fread(input, 1, (int)rn, in);
-    maxlen -= n;
-
-    /* Write the offset */
-    for (i = 0; i < 8; i++) {
-      colortemplate[i] = hex[(offset >> (28 - i * 4)) & 15];
-    }
-
-    /* Fill out the template */
-    for (i = 0; i < 16; i++) {
-      int v = input[i];
-      colortemplate[slots[i * 2 + 0] + 0] = hex[v >> 4];
-      colortemplate[slots[i * 2 + 0] + 1] = hex[v & 15];
-      colortemplate[slots[i * 2 + 1] + 0] = display(v);
-    }
-
-    /* Erase any trailing bytes */
-    for (i = n; i < 16; i++) {
-      colortemplate[slots[i * 2 + 0] + 0] = ' ';
-      colortemplate[slots[i * 2 + 0] + 1] = ' ';
-      colortemplate[slots[i * 2 + 1] + 0] = ' ';
-    }
-
-    if (!fwrite(colortemplate, sizeof(colortemplate) - 1, 1, out)) {
-      break;
-    }
-    offset += 16;
-  } while (n == 16 && maxlen > 0);
-}
+#include "hastyhex.hpp"
 
 inline bool enablevtmode() {
   HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -195,6 +46,14 @@ struct Options {
   int64_t length{-1};
   uint64_t seek{0};
   bool plaintext{false};
+  bool squeeze{true};
+  bool reverse{false};
+  bool entropy{false};
+  bool json{false};
+  size_t block{4096};
+  size_t cols{16};
+  size_t group{1};
+  bool little{false};
 };
 
 void Usage() {
@@ -207,6 +66,15 @@ OPTIONS:
   -s [--seek]                      Read from the specified offset
   -o [--out]                       Output to file instead of standard output
   -p [--plain-text]                Do not output color ("plain")
+  -A [--all]                       Display all input data, do not fold repeated lines into '*'
+  -r [--reverse]                   Convert a hastyhex or xxd hex dump back into binary
+  -e [--entropy]                   Print entropy, zero and printable ratio per block instead of a dump
+  -b [--block]                     Block size of --entropy (default 4096)
+  -j [--json]                      Print --entropy results as JSON
+  -c [--cols]                      Bytes per line: 8, 16, 32 or 64 (default 16)
+  -g [--group]                     Bytes per group: 1, 2, 4 or 8 (default 1)
+  -L [--le]                        Display groups as little endian words
+  -B [--be]                        Display groups in file order (default)
 
 Example:
   hastyhex file.exe
@@ -222,6 +90,15 @@ bool ParseArgv(int argc, wchar_t **argv, Options &opts) {
       .Add(L"length", bela::required_argument, L'n')
       .Add(L"seek", bela::required_argument, L's')
       .Add(L"plain", bela::no_argument, L'p')
+      .Add(L"all", bela::no_argument, L'A')
+      .Add(L"reverse", bela::no_argument, L'r')
+      .Add(L"entropy", bela::no_argument, L'e')
+      .Add(L"block", bela::required_argument, L'b')
+      .Add(L"json", bela::no_argument, L'j')
+      .Add(L"cols", bela::required_argument, L'c')
+      .Add(L"group", bela::required_argument, L'g')
+      .Add(L"le", bela::no_argument, L'L')
+      .Add(L"be", bela::no_argument, L'B')
       .Add(L"out", bela::required_argument, L'o');
   bela::error_code ec;
   auto result = pv.Execute(
@@ -249,6 +126,43 @@ bool ParseArgv(int argc, wchar_t **argv, Options &opts) {
         case 'p':
           opts.plaintext = true;
           break;
+        case 'A':
+          opts.squeeze = false;
+          break;
+        case 'r':
+          opts.reverse = true;
+          break;
+        case 'e':
+          opts.entropy = true;
+          break;
+        case 'b':
+          if (int64_t n = 0; bela::SimpleAtoi(oa, &n) && n > 0) {
+            opts.block = static_cast<size_t>(n);
+          }
+          break;
+        case 'j':
+          opts.json = true;
+          break;
+        case 'c':
+          if (int64_t n = 0; bela::SimpleAtoi(oa, &n) && (n == 8 || n == 16 || n == 32 || n == 64)) {
+            opts.cols = static_cast<size_t>(n);
+            break;
+          }
+          bela::FPrintF(stderr, L"hastyhex: unsupported --cols '%s', use 8, 16, 32 or 64\n", oa);
+          return false;
+        case 'g':
+          if (int64_t n = 0; bela::SimpleAtoi(oa, &n) && (n == 1 || n == 2 || n == 4 || n == 8)) {
+            opts.group = static_cast<size_t>(n);
+            break;
+          }
+          bela::FPrintF(stderr, L"hastyhex: unsupported --group '%s', use 1, 2, 4 or 8\n", oa);
+          return false;
+        case 'L':
+          opts.little = true;
+          break;
+        case 'B':
+          opts.little = false;
+          break;
         default:
           return false;
         }
@@ -296,13 +210,27 @@ int wmain(int argc, wchar_t *argv[]) {
       return 1;
     }
   }
+  if (opts.reverse) {
+    if (out == stdout) {
+      _setmode(_fileno(stdout), _O_BINARY);
+    }
+    if (bela::error_code ec; !hastyhex::Reverse(in, out, opts.cols, opts.little ? opts.group : 0, ec)) {
+      bela::FPrintF(stderr, L"hastyhex: reverse '%s': %s\n", opts.file, ec.message);
+      return 1;
+    }
+    return 0;
+  }
   if (in != stdin) {
     _fseeki64(in, opts.seek, SEEK_SET);
   }
-  if (opts.plaintext) {
-    process_plain(in, out, opts.length);
+  hastyhex::Input input(in, opts.seek, opts.length);
+  if (opts.entropy) {
+    if (bela::error_code ec; !hastyhex::Entropy(input, out, opts.seek, opts.block, opts.json, ec)) {
+      bela::FPrintF(stderr, L"hastyhex: entropy '%s': %s\n", opts.file, ec.message);
+      return 1;
+    }
     return 0;
   }
-  process_color(in, out, opts.length);
+  hastyhex::Dump(input, out, opts.cols, opts.group, opts.plaintext, opts.squeeze, opts.little);
   return 0;
 }
@@ -0,0 +1,422 @@
+// hastyhex dump mode: colored or plain lines, folded repeats and skipped sparse holes
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <io.h>
+#include <winioctl.h>
+#include <bela/base.hpp>
+#include "hastyhex.hpp"
+
+static const constexpr char hex[] = "0123456789abcdef";
+static int display(int b) {
+  static constexpr const char table[] = {
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25,
+      0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38,
+      0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b,
+      0x4c, 0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e,
+      0x5f, 0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71,
+      0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x7b, 0x7c, 0x7d, 0x7e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+      0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e, 0x2e,
+  };
+  return table[b];
+}
+
+// Layout of a dump line: Cols bytes printed in groups of Group bytes, groups are separated by a space and every 8 bytes
+// by one more. Little displays each group as a little endian word, the ASCII column keeps the file order.
+template <size_t Cols, size_t Group, bool Little> struct Layout {
+  static_assert(Cols % 8 == 0 && 64 % Cols == 0, "columns must be 8, 16, 32 or 64");
+  static_assert(Group != 0 && 8 % Group == 0, "group must be 1, 2, 4 or 8");
+  static constexpr size_t cols = Cols;
+  static constexpr bool little = Little && Group > 1;
+  // Hex column slot where byte i is displayed
+  static constexpr size_t Slot(size_t i) {
+    return Little ? (i - i % Group) + (Group - 1 - i % Group) : i;
+  }
+  // Spaces printed before hex slot i
+  static constexpr size_t Spaces(size_t i) {
+    return i == 0 ? 0 : static_cast<size_t>(i % Group == 0) + static_cast<size_t>(i % 8 == 0);
+  }
+  static constexpr size_t Spaces() {
+    size_t n = 0;
+    for (size_t i = 0; i < Cols; i++) {
+      n += Spaces(i);
+    }
+    return n;
+  }
+};
+
+// ColorLine writes an escape sequence only where the color class changes, once per run in the hex column and once per
+// run in the ASCII column; the terminal shows the same colors as with an escape before every byte.
+template <typename L> class ColorLine {
+public:
+  static constexpr size_t width = L::cols;
+  // Widen prints 16 offset digits from the first line, offsets past 4 GiB switch to them anyway
+  void Widen() { digits = 16; }
+  bool Write(FILE *out, const unsigned char *input, size_t n, uint64_t offset) {
+    char *p = line;
+    size_t i;
+    /* Write the offset */
+    if (offset > 0xFFFFFFFF) {
+      digits = 16;
+    }
+    for (i = 0; i < digits; i++) {
+      *p++ = hex[(offset >> ((digits - 1 - i) * 4)) & 15];
+    }
+    *p++ = ' ';
+    *p++ = ' ';
+
+    /* Classes and run starts in file order (ASCII column) and display order (hex column) */
+    uint8_t classes[width];
+    auto runs = hastyhex::ColorRuns(input, width, classes);
+    const unsigned char *shown = input;
+    const uint8_t *shownclasses = classes;
+    auto shownruns = runs;
+    unsigned char swapped[width];
+    uint8_t swappedclasses[width];
+    if constexpr (L::little) {
+      for (i = 0; i < width; i++) {
+        swapped[L::Slot(i)] = input[i];
+      }
+      shown = swapped;
+      shownclasses = swappedclasses;
+      shownruns = hastyhex::ColorRuns(swapped, width, swappedclasses);
+    }
+    if (n < width) {
+      /* The last line: erased bytes break the runs, color every byte */
+      runs = ~uint64_t{0};
+      shownruns = ~uint64_t{0};
+    } else if (classes[0] == shownclasses[width - 1]) {
+      /* The ASCII column continues the last run of the hex column */
+      runs &= ~uint64_t{1};
+    }
+
+    for (i = 0; i < width; i++) {
+      for (auto s = gaps[i]; s != 0; s--) {
+        *p++ = ' ';
+      }
+      if (L::Slot(i) >= n) {
+        *p++ = ' ';
+        *p++ = ' ';
+        continue;
+      }
+      if (((shownruns >> i) & 1) != 0) {
+        p = escape(p, shownclasses[i]);
+      }
+      int v = shown[i];
+      *p++ = hex[v >> 4];
+      *p++ = hex[v & 15];
+    }
+    *p++ = ' ';
+    *p++ = ' ';
+    for (i = 0; i < n; i++) {
+      if (((runs >> i) & 1) != 0) {
+        p = escape(p, classes[i]);
+      }
+      *p++ = static_cast<char>(display(input[i]));
+    }
+    for (; i < width; i++) {
+      *p++ = ' ';
+    }
+    memcpy(p, "\33[0m\n", 5);
+    p += 5;
+    return fwrite(line, static_cast<size_t>(p - line), 1, out) == 1;
+  }
+
+private:
+  static char *escape(char *p, uint8_t c) {
+    p[0] = '\33';
+    p[1] = '[';
+    p[2] = hex[c >> 4];
+    p[3] = hex[c & 15];
+    p[4] = 'm';
+    return p + 5;
+  }
+  static constexpr auto gaps = [] {
+    std::array<uint8_t, width> g{};
+    for (size_t i = 0; i < width; i++) {
+      g[i] = static_cast<uint8_t>(L::Spaces(i));
+    }
+    return g;
+  }();
+  size_t digits{8};
+  /* worst case: 16 offset digits and an escape before every byte */
+  char line[18 + width * 7 + L::Spaces() + 2 + width * 6 + 5];
+};
+
+template <typename L> class PlainLine {
+public:
+  static constexpr size_t width = L::cols;
+  PlainLine() { memcpy(plaintemplate + 8, prototype.text, size); }
+  // Widen prints 16 offset digits from the first line, offsets past 4 GiB switch to them anyway
+  void Widen() { digits = 16; }
+  bool Write(FILE *out, const unsigned char *input, size_t n, uint64_t offset) {
+    size_t i;
+    /* Write the offset, the template starts 8 chars in so a wide offset grows to the left */
+    if (offset > 0xFFFFFFFF) {
+      digits = 16;
+    }
+    char *start = plaintemplate + 16 - digits;
+    for (i = 0; i < digits; i++) {
+      start[i] = hex[(offset >> ((digits - 1 - i) * 4)) & 15];
+    }
+
+    /* Fill out the template */
+    char *text = plaintemplate + 8;
+    for (i = 0; i < width; i++) {
+      int v = input[i];
+      text[slots[i * 2 + 0] + 0] = hex[v >> 4];
+      text[slots[i * 2 + 0] + 1] = hex[v & 15];
+      text[slots[i * 2 + 1] + 0] = display(v);
+    }
+
+    /* Erase any trailing bytes */
+    for (i = n; i < width; i++) {
+      text[slots[i * 2 + 0] + 0] = ' ';
+      text[slots[i * 2 + 0] + 1] = ' ';
+      text[slots[i * 2 + 1] + 0] = ' ';
+    }
+    return fwrite(start, size + digits - 8, 1, out) == 1;
+  }
+
+private:
+  /* "00000000  ## ## ## ## ## ## ## ##  ## ## ## ## ## ## ## ##  ................\n" */
+  static constexpr size_t size = 10 + width * 2 + L::Spaces() + 2 + width + 1;
+  struct Prototype {
+    char text[size];
+    int slots[width * 2]; /* hex, ASCII */
+  };
+  static consteval Prototype Make() {
+    Prototype p{};
+    size_t pos = 0;
+    auto put = [&](const char *s) {
+      for (; *s != 0; s++) {
+        p.text[pos++] = *s;
+      }
+    };
+    int hexslots[width] = {0};
+    put("00000000  ");
+    for (size_t k = 0; k < width; k++) {
+      for (size_t s = L::Spaces(k); s != 0; s--) {
+        put(" ");
+      }
+      hexslots[k] = static_cast<int>(pos);
+      put("##");
+    }
+    put("  ");
+    for (size_t i = 0; i < width; i++) {
+      p.slots[i * 2 + 0] = hexslots[L::Slot(i)];
+      p.slots[i * 2 + 1] = static_cast<int>(pos);
+      put(".");
+    }
+    put("\n");
+    return p;
+  }
+  static constexpr Prototype prototype = Make();
+  static constexpr const int *slots = prototype.slots;
+  size_t digits{8};
+  char plaintemplate[8 + size];
+};
+
+namespace hastyhex {
+Input::Input(FILE *in_, uint64_t seek, int64_t length) : in(in_), position(seek) {
+  remaining = length > 0 ? static_cast<uint64_t>(length) : UINT64_MAX;
+  fd = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(in)));
+  if (fd == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  FILE_BASIC_INFO bi;
+  FILE_STANDARD_INFO si;
+  if (GetFileInformationByHandleEx(fd, FileBasicInfo, &bi, sizeof(bi)) != TRUE ||
+      GetFileInformationByHandleEx(fd, FileStandardInfo, &si, sizeof(si)) != TRUE) {
+    return;
+  }
+  size = static_cast<uint64_t>(si.EndOfFile.QuadPart);
+  sized = GetFileType(fd) == FILE_TYPE_DISK;
+  sparse = (bi.FileAttributes & FILE_ATTRIBUTE_SPARSE_FILE) != 0;
+}
+
+size_t Input::Read(uint8_t *buf, size_t n) {
+  auto rn = static_cast<size_t>((std::min)(remaining, static_cast<uint64_t>(n)));
+  auto got = fread(buf, 1, rn, in);
+  position += got;
+  remaining -= got;
+  return got;
+}
+
+uint64_t Input::ZeroAhead() {
+  if (!sparse || remaining == 0 || position >= size) {
+    return 0;
+  }
+  if (position >= dataStart && position < dataEnd) {
+    return 0; // inside the allocated range found last time
+  }
+  FILE_ALLOCATED_RANGE_BUFFER query;
+  query.FileOffset.QuadPart = static_cast<LONGLONG>(position);
+  query.Length.QuadPart = static_cast<LONGLONG>(size - position);
+  FILE_ALLOCATED_RANGE_BUFFER range;
+  DWORD bytes = 0;
+  // Only the first allocated range after the current position matters, ERROR_MORE_DATA is expected
+  if (DeviceIoControl(fd, FSCTL_QUERY_ALLOCATED_RANGES, &query, sizeof(query), &range, sizeof(range), &bytes,
+                      nullptr) != TRUE &&
+      GetLastError() != ERROR_MORE_DATA) {
+    sparse = false;
+    return 0;
+  }
+  auto next = size; // no allocated data until end of file
+  if (bytes >= sizeof(range)) {
+    dataStart = static_cast<uint64_t>(range.FileOffset.QuadPart);
+    dataEnd = dataStart + static_cast<uint64_t>(range.Length.QuadPart);
+    next = dataStart;
+  }
+  if (next <= position) {
+    return 0;
+  }
+  return (std::min)(next - position, remaining);
+}
+
+uint64_t Input::End() const {
+  if (sized) {
+    return position + (std::min)(position < size ? size - position : 0, remaining);
+  }
+  return remaining == UINT64_MAX ? UINT64_MAX : position + remaining;
+}
+
+bool Input::Skip(uint64_t n) {
+  if (_fseeki64(in, static_cast<int64_t>(position + n), SEEK_SET) != 0) {
+    return false;
+  }
+  position += n;
+  remaining -= n;
+  return true;
+}
+} // namespace hastyhex
+
+// process dumps the input line by line, identical consecutive lines are folded into a single '*' line (like hexdump)
+// and holes of sparse files are skipped without reading them.
+template <typename Line> static void process(hastyhex::Input &in, FILE *out, bool squeeze) {
+  constexpr size_t width = Line::width;
+  constexpr size_t blocksize = width * 4096;
+  std::vector<unsigned char> buffer(blocksize);
+  unsigned char prev[width] = {0};
+  bool hasprev = false;
+  bool folded = false;
+  uint64_t offset = 0;
+  Line line;
+  /* One offset width for the whole dump when it is known to pass 4 GiB, offsets count from the --seek position */
+  if (auto end = in.End(); end != UINT64_MAX && end - in.Position() > 0xFFFFFFFF) {
+    line.Widen();
+  }
+  auto fold = [&]() -> bool {
+    if (folded) {
+      return true;
+    }
+    folded = true;
+    return fwrite("*\n", 2, 1, out) == 1;
+  };
+  for (;;) {
+    if (squeeze && hasprev && hastyhex::IsZeroLine(prev, width)) {
+      if (auto zeros = in.ZeroAhead() / width * width; zeros != 0 && in.Skip(zeros)) {
+        if (!fold()) {
+          return; /* Output error */
+        }
+        offset += zeros;
+        continue;
+      }
+    }
+    auto n = in.Read(buffer.data(), blocksize);
+    auto lines = n / width;
+    for (size_t i = 0; i < lines;) {
+      const auto *input = buffer.data() + i * width;
+      if (squeeze && hasprev) {
+        if (auto same = hastyhex::RepeatedLines(input, lines - i, prev, width); same != 0) {
+          if (!fold()) {
+            return;
+          }
+          i += same;
+          offset += same * width;
+          continue;
+        }
+      }
+      if (!line.Write(out, input, width, offset)) {
+        return;
+      }
+      memcpy(prev, input, width);
+      hasprev = true;
+      folded = false;
+      offset += width;
+      i++;
+    }
+    if (n == blocksize) {
+      continue;
+    }
+    /* The last line: partial, or empty to show the final offset at end of file or after a fold, which -r needs to
+       know where the repeated lines stop */
+    if (auto tail = n - lines * width; tail != 0 || !in.Exhausted() || folded) {
+      line.Write(out, buffer.data() + lines * width, tail, offset);
+    }
+    return;
+  }
+}
+
+// dispatch picks the compile-time layout matching the command line
+template <template <typename> class Line, size_t Cols, size_t Group>
+static void dispatch(hastyhex::Input &in, FILE *out, bool squeeze, bool little) {
+  if constexpr (Group == 1) {
+    process<Line<Layout<Cols, 1, false>>>(in, out, squeeze);
+  } else {
+    if (little) {
+      process<Line<Layout<Cols, Group, true>>>(in, out, squeeze);
+      return;
+    }
+    process<Line<Layout<Cols, Group, false>>>(in, out, squeeze);
+  }
+}
+
+template <template <typename> class Line, size_t Cols>
+static void dispatch(hastyhex::Input &in, FILE *out, size_t group, bool squeeze, bool little) {
+  switch (group) {
+  case 2:
+    return dispatch<Line, Cols, 2>(in, out, squeeze, little);
+  case 4:
+    return dispatch<Line, Cols, 4>(in, out, squeeze, little);
+  case 8:
+    return dispatch<Line, Cols, 8>(in, out, squeeze, little);
+  default:
+    break;
+  }
+  dispatch<Line, Cols, 1>(in, out, squeeze, little);
+}
+
+template <template <typename> class Line>
+static void dispatch(hastyhex::Input &in, FILE *out, size_t cols, size_t group, bool squeeze, bool little) {
+  switch (cols) {
+  case 8:
+    return dispatch<Line, 8>(in, out, group, squeeze, little);
+  case 32:
+    return dispatch<Line, 32>(in, out, group, squeeze, little);
+  case 64:
+    return dispatch<Line, 64>(in, out, group, squeeze, little);
+  default:
+    break;
+  }
+  dispatch<Line, 16>(in, out, group, squeeze, little);
+}
+
+namespace hastyhex {
+void Dump(Input &in, FILE *out, size_t cols, size_t group, bool plain, bool squeeze, bool little) {
+  if (plain) {
+    dispatch<PlainLine>(in, out, cols, group, squeeze, little);
+    return;
+  }
+  dispatch<ColorLine>(in, out, cols, group, squeeze, little);
+}
+} // namespace hastyhex
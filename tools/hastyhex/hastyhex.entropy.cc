@@ -0,0 +1,240 @@
+// hastyhex entropy mode: per block byte histograms
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <bela/base.hpp>
+#include "hastyhex.hpp"
+
+namespace hastyhex {
+namespace {
+struct BlockStat {
+  uint64_t offset{0};
+  size_t size{0};
+  double entropy{0};
+  double zero{0};
+  double printable{0};
+};
+
+// Histogram counts bytes into four interleaved tables so consecutive equal bytes do not serialize on the same
+// counter (store-to-load forwarding), the tables are merged at the end. Counts are 64-bit, a block may pass 4 GiB.
+void Histogram(const uint8_t *p, size_t n, uint64_t counts[256]) {
+  uint64_t t[4][256] = {};
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    uint64_t v;
+    memcpy(&v, p + i, sizeof(v));
+    t[0][v & 0xFF]++;
+    t[1][(v >> 8) & 0xFF]++;
+    t[2][(v >> 16) & 0xFF]++;
+    t[3][(v >> 24) & 0xFF]++;
+    t[0][(v >> 32) & 0xFF]++;
+    t[1][(v >> 40) & 0xFF]++;
+    t[2][(v >> 48) & 0xFF]++;
+    t[3][v >> 56]++;
+  }
+  for (; i < n; i++) {
+    t[0][p[i]]++;
+  }
+  for (size_t k = 0; k < 256; k++) {
+    counts[k] = t[0][k] + t[1][k] + t[2][k] + t[3][k];
+  }
+}
+
+// printable: graphic ASCII and white space, the 'print' and 'space' classes of the color dump
+constexpr bool IsPrintable(size_t b) { return (b >= 0x20 && b <= 0x7E) || (b >= 0x09 && b <= 0x0D); }
+
+void Analyze(const uint8_t *p, size_t n, BlockStat &stat) {
+  uint64_t counts[256];
+  Histogram(p, n, counts);
+  stat.size = n;
+  if (n == 0) {
+    return;
+  }
+  double sum = 0;
+  uint64_t printable = 0;
+  for (size_t k = 0; k < 256; k++) {
+    if (auto c = counts[k]; c != 0) {
+      sum += static_cast<double>(c) * std::log2(static_cast<double>(c));
+      printable += IsPrintable(k) ? c : 0;
+    }
+  }
+  auto total = static_cast<double>(n);
+  // H = log2(n) - sum(c * log2(c)) / n
+  stat.entropy = (std::max)(0.0, std::log2(total) - sum / total);
+  stat.zero = static_cast<double>(counts[0]) / total;
+  stat.printable = static_cast<double>(printable) / total;
+}
+
+void Print(FILE *out, const BlockStat &stat, bool json, bool first) {
+  if (json) {
+    fprintf(out, "%s\n    {\"offset\": %llu, \"size\": %zu, \"entropy\": %.4f, \"zero\": %.4f, \"printable\": %.4f}",
+            first ? "" : ",", static_cast<unsigned long long>(stat.offset), stat.size, stat.entropy, stat.zero,
+            stat.printable);
+    return;
+  }
+  // entropy bar: one '#' per quarter bit
+  char bar[33];
+  auto len = static_cast<size_t>(stat.entropy * 4 + 0.5);
+  memset(bar, '#', len);
+  bar[len] = 0;
+  fprintf(out, "%08llx  %6.4f  %6.2f%%  %6.2f%%  %s\n", static_cast<unsigned long long>(stat.offset), stat.entropy,
+          stat.zero * 100, stat.printable * 100, bar);
+}
+
+// BlockPool: the workers live for the whole run. Each chunk is handed out one block at a time through an atomic
+// cursor, Wait returns once every block is analyzed and every worker is idle again.
+class BlockPool {
+public:
+  explicit BlockPool(size_t threads) {
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+      workers.emplace_back([this] { work(); });
+    }
+  }
+  BlockPool(const BlockPool &) = delete;
+  BlockPool &operator=(const BlockPool &) = delete;
+  ~BlockPool() {
+    {
+      std::lock_guard lock(mu);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t : workers) {
+      t.join();
+    }
+  }
+  void Start(const uint8_t *data_, size_t n_, uint64_t offset_, size_t blockSize_, BlockStat *stats_) {
+    {
+      // a worker that woke late for the previous chunk may still be reading it
+      std::unique_lock lock(mu);
+      done.wait(lock, [this] { return active == 0; });
+      data = data_;
+      n = n_;
+      offset = offset_;
+      blockSize = blockSize_;
+      stats = stats_;
+      count = (n + blockSize - 1) / blockSize;
+      finished = 0;
+      next = 0;
+      generation++;
+    }
+    wake.notify_all();
+  }
+  void Wait() {
+    std::unique_lock lock(mu);
+    done.wait(lock, [this] { return finished == count && active == 0; });
+  }
+
+private:
+  void work() {
+    uint64_t seen = 0;
+    std::unique_lock lock(mu);
+    for (;;) {
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+      if (stopping) {
+        return;
+      }
+      seen = generation;
+      active++;
+      lock.unlock();
+      size_t analyzed = 0;
+      for (auto i = next++; i < count; i = next++) {
+        auto pos = i * blockSize;
+        stats[i].offset = offset + pos;
+        Analyze(data + pos, (std::min)(blockSize, n - pos), stats[i]);
+        analyzed++;
+      }
+      lock.lock();
+      finished += analyzed;
+      active--;
+      done.notify_all();
+    }
+  }
+  std::mutex mu;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::vector<std::thread> workers;
+  uint64_t generation{0};
+  bool stopping{false};
+  size_t active{0};   // workers inside a chunk
+  size_t finished{0}; // blocks analyzed
+  // the chunk, written by Start while every worker is idle
+  const uint8_t *data{nullptr};
+  size_t n{0};
+  uint64_t offset{0};
+  size_t blockSize{0};
+  BlockStat *stats{nullptr};
+  size_t count{0};
+  std::atomic_size_t next{0};
+};
+
+} // namespace
+
+bool Entropy(Input &in, FILE *out, uint64_t seek, size_t blockSize, bool json, bela::error_code &ec) {
+  if (blockSize == 0) {
+    ec = bela::make_error_code(ErrGeneral, L"block size must be greater than zero");
+    return false;
+  }
+  // a chunk of whole blocks is analyzed by the workers while the next one is being read
+  constexpr size_t chunkSize = 32 * 1024 * 1024;
+  auto blocks = (std::max)(size_t{1}, chunkSize / blockSize);
+  auto threads = (std::max)(size_t{1}, static_cast<size_t>(std::thread::hardware_concurrency()));
+  std::vector<uint8_t> buffers[2];
+  std::vector<BlockStat> stats[2];
+  for (size_t i = 0; i < 2; i++) {
+    buffers[i].resize(blocks * blockSize);
+    stats[i].resize(blocks);
+  }
+  auto fill = [&](std::vector<uint8_t> &buf) -> size_t {
+    size_t n = 0;
+    while (n < buf.size()) {
+      auto got = in.Read(buf.data() + n, buf.size() - n);
+      if (got == 0) {
+        break;
+      }
+      n += got;
+    }
+    return n;
+  };
+  if (json) {
+    fprintf(out, "{\n  \"block_size\": %zu,\n  \"blocks\": [", blockSize);
+  } else {
+    fprintf(out, "offset    entropy     zero  printable\n");
+  }
+  BlockPool pool(threads);
+  uint64_t offset = seek;
+  bool first = true;
+  size_t current = 0;
+  auto n = fill(buffers[current]);
+  while (n != 0) {
+    auto count = (n + blockSize - 1) / blockSize;
+    auto &buf = buffers[current];
+    auto &stat = stats[current];
+    pool.Start(buf.data(), n, offset, blockSize, stat.data());
+    auto next = buf.size() == n ? fill(buffers[current ^ 1]) : 0;
+    pool.Wait();
+    for (size_t i = 0; i < count; i++) {
+      Print(out, stat[i], json, first);
+      first = false;
+    }
+    offset += n;
+    n = next;
+    current ^= 1;
+  }
+  if (json) {
+    fprintf(out, "\n  ]\n}\n");
+  }
+  if (ferror(out) != 0) {
+    ec = bela::make_error_code(ErrGeneral, L"write: ", tlsstrerror(errno));
+    return false;
+  }
+  return true;
+}
+
+} // namespace hastyhex
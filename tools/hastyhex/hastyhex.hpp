@@ -0,0 +1,214 @@
+// hastyhex shared helpers
+#ifndef HASTYHEX_HPP
+#define HASTYHEX_HPP
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <bela/base.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HASTYHEX_SSE2 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define HASTYHEX_NEON 1
+#endif
+
+const wchar_t *tlsstrerror(int ec);
+
+namespace hastyhex {
+
+// Input reads the dumped range of a file in large blocks. On sparse files it can report unallocated holes ahead of
+// the current position so callers may skip them without reading (FSCTL_QUERY_ALLOCATED_RANGES).
+class Input {
+public:
+  Input(FILE *in_, uint64_t seek, int64_t length);
+  Input(const Input &) = delete;
+  Input &operator=(const Input &) = delete;
+  // Read reads up to n bytes, a short read means end of file or the length limit was reached
+  size_t Read(uint8_t *buf, size_t n);
+  // ZeroAhead returns the number of bytes from the current position known to be a hole (read as zero)
+  uint64_t ZeroAhead();
+  // Skip advances the current position by n bytes without reading them
+  bool Skip(uint64_t n);
+  // Exhausted reports whether the length limit (-n) has been consumed
+  bool Exhausted() const { return remaining == 0; }
+  // End returns the file offset the dump stops at, UINT64_MAX when neither the file size nor a length is known
+  uint64_t End() const;
+  // Position returns the file offset of the next byte Read returns
+  uint64_t Position() const { return position; }
+
+private:
+  FILE *in{nullptr};
+  HANDLE fd{INVALID_HANDLE_VALUE};
+  uint64_t position{0};
+  uint64_t remaining{UINT64_MAX};
+  uint64_t size{0};
+  uint64_t dataStart{0};
+  uint64_t dataEnd{0};
+  bool sparse{false};
+  bool sized{false};
+};
+
+// RepeatedLines returns the number of leading lines of p (lines * width bytes) equal to prev.
+// width must divide 64, lines are compared 64 bytes at a time against prev repeated.
+inline size_t RepeatedLines(const uint8_t *p, size_t lines, const uint8_t *prev, size_t width) {
+  size_t total = lines * width;
+  size_t i = 0;
+#if defined(HASTYHEX_SSE2) || defined(HASTYHEX_NEON)
+  alignas(64) uint8_t period[64];
+  for (size_t k = 0; k < sizeof(period); k += width) {
+    memcpy(period + k, prev, width);
+  }
+#endif
+#if defined(__AVX2__)
+  const __m256i q0 = _mm256_load_si256(reinterpret_cast<const __m256i *>(period));
+  const __m256i q1 = _mm256_load_si256(reinterpret_cast<const __m256i *>(period + 32));
+  for (; i + 64 <= total; i += 64) {
+    auto a = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)), q0);
+    auto b = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i + 32)), q1);
+    if (static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(a, b))) != 0xFFFFFFFFU) {
+      break;
+    }
+  }
+#elif defined(HASTYHEX_SSE2)
+  const __m128i q0 = _mm_load_si128(reinterpret_cast<const __m128i *>(period));
+  const __m128i q1 = _mm_load_si128(reinterpret_cast<const __m128i *>(period + 16));
+  const __m128i q2 = _mm_load_si128(reinterpret_cast<const __m128i *>(period + 32));
+  const __m128i q3 = _mm_load_si128(reinterpret_cast<const __m128i *>(period + 48));
+  for (; i + 64 <= total; i += 64) {
+    auto a = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), q0);
+    auto b = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 16)), q1);
+    auto c = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 32)), q2);
+    auto d = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i + 48)), q3);
+    if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(a, b), _mm_and_si128(c, d))) != 0xFFFF) {
+      break;
+    }
+  }
+#elif defined(HASTYHEX_NEON)
+  const uint8x16_t q0 = vld1q_u8(period);
+  const uint8x16_t q1 = vld1q_u8(period + 16);
+  const uint8x16_t q2 = vld1q_u8(period + 32);
+  const uint8x16_t q3 = vld1q_u8(period + 48);
+  for (; i + 64 <= total; i += 64) {
+    auto a = vceqq_u8(vld1q_u8(p + i), q0);
+    auto b = vceqq_u8(vld1q_u8(p + i + 16), q1);
+    auto c = vceqq_u8(vld1q_u8(p + i + 32), q2);
+    auto d = vceqq_u8(vld1q_u8(p + i + 48), q3);
+    if (vminvq_u8(vandq_u8(vandq_u8(a, b), vandq_u8(c, d))) != 0xFF) {
+      break;
+    }
+  }
+#endif
+  // i is a multiple of 64 and therefore of width: finish line by line
+  size_t n = i / width;
+  for (; n < lines && memcmp(p + n * width, prev, width) == 0; n++) {
+  }
+  return n;
+}
+
+inline bool IsZeroLine(const uint8_t *p, size_t width) {
+  for (size_t i = 0; i < width; i++) {
+    if (p[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Color classes of the color dump, the value is the SGR code: null, space, print, control and high bytes
+constexpr uint8_t ColorNull = 0x90;
+constexpr uint8_t ColorSpace = 0x92;
+constexpr uint8_t ColorPrint = 0x96;
+constexpr uint8_t ColorControl = 0x95;
+constexpr uint8_t ColorHigh = 0x93;
+
+constexpr uint8_t ColorClass(uint8_t b) {
+  if (b == 0) {
+    return ColorNull;
+  }
+  if (b >= 0x80) {
+    return ColorHigh;
+  }
+  if (b == 0x20 || (b >= 0x0A && b <= 0x0D)) {
+    return ColorSpace;
+  }
+  if (b > 0x20 && b < 0x7F) {
+    return ColorPrint;
+  }
+  return ColorControl;
+}
+
+// ColorRuns stores the color class of n (at most 64) bytes into classes and returns a mask with bit i set when byte i
+// starts a run of its class, so only those bytes need an escape sequence.
+inline uint64_t ColorRuns(const uint8_t *p, size_t n, uint8_t *classes) {
+  uint64_t runs = 0;
+  size_t i = 0;
+#if defined(HASTYHEX_SSE2)
+  auto blend = [](__m128i m, uint8_t value, __m128i cls) {
+    return _mm_or_si128(_mm_and_si128(m, _mm_set1_epi8(static_cast<char>(value))), _mm_andnot_si128(m, cls));
+  };
+  __m128i prev = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    /* signed compares: high bytes are negative */
+    auto print = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x20)), _mm_cmplt_epi8(v, _mm_set1_epi8(0x7F)));
+    auto blank = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(0x09)), _mm_cmplt_epi8(v, _mm_set1_epi8(0x0E)));
+    auto space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(0x20)), blank);
+    auto cls = _mm_set1_epi8(static_cast<char>(ColorControl));
+    cls = blend(print, ColorPrint, cls);
+    cls = blend(space, ColorSpace, cls);
+    cls = blend(_mm_cmplt_epi8(v, _mm_setzero_si128()), ColorHigh, cls);
+    cls = blend(_mm_cmpeq_epi8(v, _mm_setzero_si128()), ColorNull, cls);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(classes + i), cls);
+    auto shifted = _mm_or_si128(_mm_slli_si128(cls, 1), _mm_srli_si128(prev, 15));
+    auto same = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(cls, shifted)));
+    runs |= static_cast<uint64_t>(~same & 0xFFFF) << i;
+    prev = cls;
+  }
+#elif defined(HASTYHEX_NEON)
+  static constexpr uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+  const auto bits = vld1q_u8(weights);
+  uint8x16_t prev = vdupq_n_u8(0);
+  for (; i + 16 <= n; i += 16) {
+    auto v = vld1q_u8(p + i);
+    auto print = vandq_u8(vcgtq_u8(v, vdupq_n_u8(0x20)), vcltq_u8(v, vdupq_n_u8(0x7F)));
+    auto space = vorrq_u8(vceqq_u8(v, vdupq_n_u8(0x20)), vcltq_u8(vsubq_u8(v, vdupq_n_u8(0x0A)), vdupq_n_u8(4)));
+    auto cls = vdupq_n_u8(ColorControl);
+    cls = vbslq_u8(print, vdupq_n_u8(ColorPrint), cls);
+    cls = vbslq_u8(space, vdupq_n_u8(ColorSpace), cls);
+    cls = vbslq_u8(vcgeq_u8(v, vdupq_n_u8(0x80)), vdupq_n_u8(ColorHigh), cls);
+    cls = vbslq_u8(vceqq_u8(v, vdupq_n_u8(0)), vdupq_n_u8(ColorNull), cls);
+    vst1q_u8(classes + i, cls);
+    auto start = vandq_u8(vmvnq_u8(vceqq_u8(cls, vextq_u8(prev, cls, 15))), bits);
+    auto mask = static_cast<uint64_t>(vaddv_u8(vget_low_u8(start))) |
+                (static_cast<uint64_t>(vaddv_u8(vget_high_u8(start))) << 8);
+    runs |= mask << i;
+    prev = cls;
+  }
+#endif
+  for (; i < n; i++) {
+    classes[i] = ColorClass(p[i]);
+    if (i == 0 || classes[i] != classes[i - 1]) {
+      runs |= uint64_t{1} << i;
+    }
+  }
+  return runs;
+}
+
+// Dump writes in as lines of cols bytes in groups of group bytes, little shows the groups as little endian words.
+// plain leaves out the colors, squeeze folds repeated lines into '*' and skips the holes of sparse files.
+void Dump(Input &in, FILE *out, size_t cols, size_t group, bool plain, bool squeeze, bool little);
+
+// Reverse converts a hastyhex (plain or color) or xxd dump read from in back into binary, width is the number of bytes
+// per dumped line and swap the word size of a little endian (--le) dump or 0. Folded '*' lines repeat the previous
+// line up to the next offset, gaps between offsets are zero filled.
+bool Reverse(FILE *in, FILE *out, size_t width, size_t swap, bela::error_code &ec);
+
+// Entropy prints the Shannon entropy, zero ratio and printable ratio of every blockSize bytes block read from in,
+// seek is the file offset of the first block. Blocks are analyzed in parallel while the next chunk is read.
+bool Entropy(Input &in, FILE *out, uint64_t seek, size_t blockSize, bool json, bela::error_code &ec);
+
+} // namespace hastyhex
+
+#endif
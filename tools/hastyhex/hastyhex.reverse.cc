@@ -0,0 +1,397 @@
+// hastyhex reverse mode: turn a hex dump back into binary
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <bela/base.hpp>
+#include "hastyhex.hpp"
+
+namespace hastyhex {
+namespace {
+constexpr uint8_t expectAny = 0;
+constexpr uint8_t expectHex = 1;
+constexpr uint8_t expectSpace = 2;
+
+// ReverseLayout describes a well-formed 16 bytes line of a known dump format
+struct ReverseLayout {
+  char separator{0};     // char after the offset: ' ' hastyhex, ':' xxd
+  size_t span{0};        // validated window length, the ASCII column follows
+  uint8_t high[16]{0};   // window position of the high nibble of each byte
+  uint8_t expect[64]{0}; // expected class of each window char
+};
+
+// MakeLayout: bytes are printed in groups of 'group' bytes separated by a space, 'middle' adds the extra space
+// hastyhex prints after 8 bytes. Both formats end the hex column with two spaces.
+consteval ReverseLayout MakeLayout(char separator, size_t group, bool middle) {
+  ReverseLayout l;
+  l.separator = separator;
+  size_t pos = 1;
+  for (size_t k = 0; k < 16; k++) {
+    if (k != 0 && k % group == 0) {
+      pos++;
+    }
+    if (k == 8 && middle) {
+      pos++;
+    }
+    l.high[k] = static_cast<uint8_t>(pos);
+    l.expect[pos] = expectHex;
+    l.expect[pos + 1] = expectHex;
+    pos += 2;
+  }
+  l.span = pos + 2;
+  for (size_t i = 0; i < l.span; i++) {
+    if (l.expect[i] == expectAny) {
+      l.expect[i] = expectSpace;
+    }
+  }
+  return l;
+}
+
+constexpr ReverseLayout hastyhexLayout = MakeLayout(' ', 1, true);
+constexpr ReverseLayout xxdLayout = MakeLayout(':', 2, false);
+
+inline int HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (auto l = c | 0x20; l >= 'a' && l <= 'f') {
+    return l - 'a' + 10;
+  }
+  return -1;
+}
+
+// DecodeFast decodes a well-formed line with SIMD, the buffer must stay readable 64 bytes past e. The offset has 8
+// digits, or 16 in hastyhex dumps longer than 4 GiB, the window starts right after it and its separator char.
+// Returns false when the line does not match the layout exactly, the caller then falls back to ParseLine.
+bool DecodeFast(const ReverseLayout &l, const char *p, const char *e, uint64_t &offset, size_t &digits, uint8_t *out) {
+#if defined(HASTYHEX_SSE2) || defined(HASTYHEX_NEON)
+  auto length = static_cast<size_t>(e - p);
+  size_t n = 8;
+  if (length > 16 && p[8] != l.separator && p[16] == l.separator) {
+    n = 16;
+  }
+  if (length < n + 1 + l.span || p[n] != l.separator) {
+    return false;
+  }
+  uint64_t o = 0;
+  for (size_t i = 0; i < n; i++) {
+    auto v = HexValue(p[i]);
+    if (v < 0) {
+      return false;
+    }
+    o = (o << 4) | static_cast<uint64_t>(v);
+  }
+  const auto *w = reinterpret_cast<const uint8_t *>(p + n + 1);
+  alignas(16) uint8_t nibbles[64];
+#if defined(HASTYHEX_SSE2)
+  const auto bias = _mm_set1_epi8(static_cast<char>(0x80));
+  // unsigned a < n with signed compares
+  auto ult = [&](__m128i a, int n) {
+    return _mm_cmplt_epi8(_mm_xor_si128(a, bias), _mm_set1_epi8(static_cast<char>(n ^ 0x80)));
+  };
+  __m128i mismatch = _mm_setzero_si128();
+  for (size_t i = 0; i < 64; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + i));
+    auto d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    auto a = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    auto isdigit = ult(d, 10);
+    auto isalpha = ult(a, 6);
+    auto isspace = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    auto expect = _mm_load_si128(reinterpret_cast<const __m128i *>(l.expect + i));
+    auto wanthex = _mm_cmpeq_epi8(expect, _mm_set1_epi8(expectHex));
+    auto wantspace = _mm_cmpeq_epi8(expect, _mm_set1_epi8(expectSpace));
+    mismatch = _mm_or_si128(mismatch, _mm_andnot_si128(_mm_or_si128(isdigit, isalpha), wanthex));
+    mismatch = _mm_or_si128(mismatch, _mm_andnot_si128(isspace, wantspace));
+    auto nibble = _mm_or_si128(_mm_and_si128(isdigit, d), _mm_and_si128(isalpha, _mm_add_epi8(a, _mm_set1_epi8(10))));
+    _mm_store_si128(reinterpret_cast<__m128i *>(nibbles + i), nibble);
+  }
+  if (_mm_movemask_epi8(mismatch) != 0) {
+    return false;
+  }
+#else
+  uint8x16_t mismatch = vdupq_n_u8(0);
+  for (size_t i = 0; i < 64; i += 16) {
+    auto v = vld1q_u8(w + i);
+    auto d = vsubq_u8(v, vdupq_n_u8('0'));
+    auto a = vsubq_u8(vorrq_u8(v, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    auto isdigit = vcltq_u8(d, vdupq_n_u8(10));
+    auto isalpha = vcltq_u8(a, vdupq_n_u8(6));
+    auto isspace = vceqq_u8(v, vdupq_n_u8(' '));
+    auto expect = vld1q_u8(l.expect + i);
+    auto wanthex = vceqq_u8(expect, vdupq_n_u8(expectHex));
+    auto wantspace = vceqq_u8(expect, vdupq_n_u8(expectSpace));
+    mismatch = vorrq_u8(mismatch, vbicq_u8(wanthex, vorrq_u8(isdigit, isalpha)));
+    mismatch = vorrq_u8(mismatch, vbicq_u8(wantspace, isspace));
+    vst1q_u8(nibbles + i, vorrq_u8(vandq_u8(isdigit, d), vandq_u8(isalpha, vaddq_u8(a, vdupq_n_u8(10)))));
+  }
+  if (vmaxvq_u8(mismatch) != 0) {
+    return false;
+  }
+#endif
+  for (size_t k = 0; k < 16; k++) {
+    out[k] = static_cast<uint8_t>((nibbles[l.high[k]] << 4) | nibbles[l.high[k] + 1]);
+  }
+  offset = o;
+  digits = n;
+  return true;
+#else
+  (void)l, (void)p, (void)e, (void)offset, (void)digits, (void)out;
+  return false;
+#endif
+}
+
+enum class LineKind { Empty, Data, Fold, Malformed };
+
+// HexColumnLength: chars of a full hex column of width bytes in words of swap bytes. hastyhex separates the words by
+// a space and every 8 bytes by one more, xxd -e only by a space.
+constexpr size_t HexColumnLength(size_t width, size_t swap, bool xxd) {
+  size_t n = width * 2;
+  for (size_t k = swap; k < width; k += swap) {
+    n += (xxd || k % 8 != 0) ? 1 : 2;
+  }
+  return n;
+}
+
+// ParseLine is the tolerant path: any spacing, upper case digits, xxd groups, color escapes and offsets wider than 8
+// digits. The hex column ends after 'width' bytes, at a run of three or more spaces or at a non-hex token. With
+// swap > 1 every token is a little endian word of up to swap bytes; the leading bytes of a partial word are blank, so
+// blanks say nothing and the column ends where the layout puts it, two chars after the offset plus its full length.
+LineKind ParseLine(const char *p, const char *e, size_t width, size_t swap, uint64_t &offset, size_t &digits,
+                   std::vector<uint8_t> &bytes) {
+  size_t col = 0; // visible chars consumed, color escapes do not count
+  auto skipEscape = [&]() {
+    while (p < e && *p == '\33') {
+      while (p < e && *p != 'm') {
+        p++;
+      }
+      if (p < e) {
+        p++;
+      }
+    }
+  };
+  auto skipSpaces = [&]() -> size_t {
+    size_t n = 0;
+    for (;;) {
+      skipEscape();
+      if (p >= e || (*p != ' ' && *p != '\t' && *p != '\r')) {
+        return n;
+      }
+      n++;
+      col++;
+      p++;
+    }
+  };
+  bytes.clear();
+  skipSpaces();
+  if (p == e) {
+    return LineKind::Empty;
+  }
+  if (*p == '*') {
+    p++;
+    skipSpaces();
+    return p == e ? LineKind::Fold : LineKind::Malformed;
+  }
+  offset = 0;
+  digits = 0;
+  auto start = col;
+  for (; p < e && HexValue(*p) >= 0; p++, digits++) {
+    offset = (offset << 4) | static_cast<uint64_t>(HexValue(*p));
+  }
+  if (digits == 0 || digits > 16) {
+    return LineKind::Malformed;
+  }
+  col += digits;
+  auto xxd = p < e && *p == ':';
+  if (xxd) {
+    p++;
+    col++;
+  }
+  auto hexEnd = swap > 1 ? start + digits + 2 + HexColumnLength(width, swap, xxd) : SIZE_MAX;
+  while (bytes.size() < width) {
+    auto spaces = skipSpaces();
+    if (p == e || col >= hexEnd || (swap <= 1 && spaces >= 3)) {
+      break;
+    }
+    // a token may span color escapes, they precede every byte of a group
+    auto first = bytes.size();
+    size_t nibbles = 0;
+    int high = 0;
+    for (;;) {
+      skipEscape();
+      auto v = p < e ? HexValue(*p) : -1;
+      if (v < 0) {
+        break;
+      }
+      p++;
+      col++;
+      if (nibbles++ % 2 == 0) {
+        high = v;
+        continue;
+      }
+      if (bytes.size() < width) {
+        bytes.push_back(static_cast<uint8_t>((high << 4) | v));
+      }
+    }
+    if (p < e && *p != ' ' && *p != '\t' && *p != '\r') {
+      bytes.resize(first);
+      break; // not a hex token, the ASCII column starts
+    }
+    if (nibbles % 2 != 0) {
+      return LineKind::Malformed;
+    }
+    if (swap > 1) {
+      std::reverse(bytes.begin() + first, bytes.end());
+    }
+  }
+  return LineKind::Data;
+}
+
+class Reverser {
+public:
+  Reverser(FILE *out_, size_t width_, size_t swap_) : out(out_), width(width_), swap(swap_) {
+    buffer.reserve(bufferSize);
+  }
+  bool Line(const char *p, const char *e, bela::error_code &ec);
+  bool Flush(bela::error_code &ec) {
+    if (!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+      ec = bela::make_error_code(ErrGeneral, L"write: ", tlsstrerror(errno));
+      return false;
+    }
+    buffer.clear();
+    return true;
+  }
+
+private:
+  static constexpr size_t bufferSize = 1024 * 1024;
+  FILE *out{nullptr};
+  size_t width{16};
+  size_t swap{0};
+  uint64_t lineno{0};
+  uint64_t written{0};
+  bool folding{false};
+  std::vector<uint8_t> buffer;
+  std::vector<uint8_t> prev;
+  std::vector<uint8_t> bytes;
+  bool Append(const uint8_t *data, size_t len, bela::error_code &ec) {
+    if (buffer.size() + len > bufferSize && !Flush(ec)) {
+      return false;
+    }
+    buffer.insert(buffer.end(), data, data + len);
+    written += len;
+    return true;
+  }
+  bool Fill(uint64_t target, bela::error_code &ec);
+  bool Data(uint64_t offset, size_t digits, const uint8_t *data, size_t len, bela::error_code &ec);
+};
+
+// Fill writes up to target: the previous line repeated after a '*' fold, zeros for any other gap
+bool Reverser::Fill(uint64_t target, bela::error_code &ec) {
+  if (!folding || prev.empty()) {
+    static constexpr uint8_t zeros[4096] = {0};
+    while (written < target) {
+      if (!Append(zeros, static_cast<size_t>((std::min)(target - written, uint64_t{sizeof(zeros)})), ec)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  while (written < target) {
+    if (!Append(prev.data(), static_cast<size_t>((std::min)(target - written, uint64_t{prev.size()})), ec)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Reverser::Data(uint64_t offset, size_t digits, const uint8_t *data, size_t len, bela::error_code &ec) {
+  if (digits == 8) {
+    // hastyhex prints the low 32 bits of the offset, carry the high bits over 4 GiB boundaries
+    offset |= written & ~uint64_t{0xFFFFFFFF};
+    if (offset < written) {
+      offset += uint64_t{0x100000000};
+    }
+  }
+  if (offset < written) {
+    ec = bela::make_error_code(ErrGeneral, L"line ", lineno, L": offset goes backwards");
+    return false;
+  }
+  if (!Fill(offset, ec) || !Append(data, len, ec)) {
+    return false;
+  }
+  folding = false;
+  if (len != 0) {
+    prev.assign(data, data + len);
+  }
+  return true;
+}
+
+bool Reverser::Line(const char *p, const char *e, bela::error_code &ec) {
+  lineno++;
+  uint64_t offset = 0;
+  size_t digits = 0;
+  uint8_t line[16];
+  if (width == 16 && swap == 0 &&
+      (DecodeFast(hastyhexLayout, p, e, offset, digits, line) || DecodeFast(xxdLayout, p, e, offset, digits, line))) {
+    return Data(offset, digits, line, sizeof(line), ec);
+  }
+  switch (ParseLine(p, e, width, swap, offset, digits, bytes)) {
+  case LineKind::Empty:
+    return true;
+  case LineKind::Fold:
+    folding = true;
+    return true;
+  case LineKind::Data:
+    return Data(offset, digits, bytes.data(), bytes.size(), ec);
+  default:
+    break;
+  }
+  ec = bela::make_error_code(ErrGeneral, L"line ", lineno, L": malformed hex dump line");
+  return false;
+}
+
+} // namespace
+
+bool Reverse(FILE *in, FILE *out, size_t width, size_t swap, bela::error_code &ec) {
+  constexpr size_t blockSize = 1024 * 1024;
+  constexpr size_t padding = 64; // DecodeFast reads a full 64 bytes window
+  std::vector<char> buffer(blockSize + padding);
+  Reverser r(out, width, swap);
+  size_t used = 0;
+  for (;;) {
+    auto n = fread(buffer.data() + used, 1, blockSize - used, in);
+    used += n;
+    const char *p = buffer.data();
+    const char *end = buffer.data() + used;
+    for (;;) {
+      const auto *nl = reinterpret_cast<const char *>(memchr(p, '\n', end - p));
+      if (nl == nullptr) {
+        break;
+      }
+      if (!r.Line(p, nl, ec)) {
+        return false;
+      }
+      p = nl + 1;
+    }
+    auto rest = static_cast<size_t>(end - p);
+    if (n == 0) {
+      // last line without newline
+      if (rest != 0 && !r.Line(p, end, ec)) {
+        return false;
+      }
+      break;
+    }
+    if (rest == blockSize) {
+      ec = bela::make_error_code(ErrGeneral, L"line too long");
+      return false;
+    }
+    memmove(buffer.data(), p, rest);
+    used = rest;
+  }
+  if (ferror(in) != 0) {
+    ec = bela::make_error_code(ErrGeneral, L"read: ", tlsstrerror(errno));
+    return false;
+  }
+  return r.Flush(ec);
+}
+
+} // namespace hastyhex
@@ -0,0 +1,105 @@
+//
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bela/terminal.hpp>
+#include "../hastyhex.hpp"
+
+// dump: inputs with repeated and zero lines go through hastyhex::Dump, with -n, -s and the layouts, and the dump must
+// give the dumped range back through hastyhex::Reverse. A fold at the very end of -n needs the closing offset line.
+const wchar_t *tlsstrerror(int ec) {
+  static thread_local wchar_t buffer[512];
+  if (_wcserror_s(buffer, ec) != 0) {
+    return L"unkown error";
+  }
+  return buffer;
+}
+
+std::string zeros(size_t n) { return std::string(n, '\0'); }
+
+std::string repeat(std::string_view s, size_t n) {
+  std::string out;
+  for (size_t i = 0; i < n; i++) {
+    out.append(s);
+  }
+  return out;
+}
+
+struct dump_case {
+  const char *name;
+  std::string data;
+  uint64_t seek;
+  int64_t length;
+  size_t cols;
+  size_t group;
+  bool little;
+  bool plain;
+  bool squeeze;
+};
+
+bool run(const dump_case &c) {
+  auto in = tmpfile();
+  auto dump = tmpfile();
+  auto out = tmpfile();
+  if (in == nullptr || dump == nullptr || out == nullptr) {
+    bela::FPrintF(stderr, L"tmpfile failed\n");
+    return false;
+  }
+  auto closer = bela::finally([&] {
+    fclose(in);
+    fclose(dump);
+    fclose(out);
+  });
+  fwrite(c.data.data(), 1, c.data.size(), in);
+  fflush(in);
+  _fseeki64(in, static_cast<int64_t>(c.seek), SEEK_SET);
+  {
+    hastyhex::Input input(in, c.seek, c.length);
+    hastyhex::Dump(input, dump, c.cols, c.group, c.plain, c.squeeze, c.little);
+  }
+  rewind(dump);
+  bela::error_code ec;
+  if (!hastyhex::Reverse(dump, out, c.cols, c.little ? c.group : 0, ec)) {
+    bela::FPrintF(stderr, L"%s: %s\n", c.name, ec.message);
+    return false;
+  }
+  auto want = std::string_view{c.data}.substr(static_cast<size_t>(c.seek));
+  if (c.length > 0) {
+    want = want.substr(0, static_cast<size_t>(c.length));
+  }
+  std::string got(want.size() + 64, '\0');
+  rewind(out);
+  got.resize(fread(got.data(), 1, got.size(), out));
+  if (got != want) {
+    bela::FPrintF(stderr, L"%s: got %d bytes back, want %d\n", c.name, got.size(), want.size());
+    return false;
+  }
+  return true;
+}
+
+int wmain() {
+  auto text = repeat("hastyhex dump -n", 6) + "tail";
+  const dump_case cases[] = {
+      {"-n at the end of a fold", zeros(4096), 0, 4096, 16, 1, false, true, true},
+      {"-n inside a longer file", zeros(8192), 0, 4096, 16, 1, false, true, true},
+      {"-n at the end of a fold, color", zeros(4096), 0, 4096, 16, 1, false, false, true},
+      {"text then zeros, -n", text + zeros(4096), 0, 4096, 16, 1, false, true, true},
+      {"text then zeros to end of file", text + zeros(4000), 0, -1, 16, 1, false, true, true},
+      {"repeated text lines, -n", repeat("0123456789abcdef", 300), 0, 320 * 8, 16, 1, false, true, true},
+      {"-s and -n", text + zeros(4096), 16, 4080, 16, 1, false, true, true},
+      {"-n mid line", text + zeros(4096), 0, 4001, 16, 1, false, true, true},
+      {"-A and -n", zeros(4096), 0, 4096, 16, 1, false, true, false},
+      {"--le words of 4, 32 columns, -n", text + zeros(4096), 0, 4096, 32, 4, true, true, true},
+      {"8 columns, color, -n", repeat("abcdefgh", 64), 0, 256, 8, 1, false, false, true},
+  };
+  int status = 0;
+  for (const auto &c : cases) {
+    if (!run(c)) {
+      status = 1;
+    }
+  }
+  bela::FPrintF(stdout, L"%d cases, %s\n", std::size(cases), status == 0 ? L"ok" : L"failed");
+  return status;
+}
@@ -0,0 +1,92 @@
+//
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <bela/terminal.hpp>
+#include "../hastyhex.hpp"
+
+// reverse: hand checked dumps go through hastyhex::Reverse and must give their bytes back. The --le lines end with a
+// partial word padded in front and an ASCII column of hex digits, which only the layout tells apart from the words.
+const wchar_t *tlsstrerror(int ec) {
+  static thread_local wchar_t buffer[512];
+  if (_wcserror_s(buffer, ec) != 0) {
+    return L"unkown error";
+  }
+  return buffer;
+}
+
+struct reverse_case {
+  const char *name;
+  std::string_view dump;
+  size_t width;
+  size_t swap;
+  std::string_view want;
+};
+
+constexpr reverse_case cases[] = {
+    {"le words of 4, partial last word",
+     "00000000  64616564 66656562  65666163     3130  deadbeefcafe01  \n", 16, 4, "deadbeefcafe01"},
+    {"le words of 2, one byte in the last word",
+     "00000000  6564 6461 6562 6665  6163 6566 3130   32  deadbeefcafe012 \n", 16, 2, "deadbeefcafe012"},
+    {"le words of 8, short second line",
+     "00000000  3736353433323130  6665646362613938  0123456789abcdef\n"
+     "00000010          66656562                    beef            \n",
+     16, 8, "0123456789abcdefbeef"},
+    {"le words of 4, color",
+     "00000000  \33[96m64\33[96m61\33[96m65\33[96m64 \33[96m66\33[96m65\33[96m65\33[96m62  \33[96m65\33[96m66\33[96m61"
+     "\33[96m63     \33[96m31\33[96m30  \33[96md\33[96me\33[96ma\33[96md\33[96mb\33[96me\33[96me\33[96mf\33[96mc"
+     "\33[96ma\33[96mf\33[96me\33[96m0\33[96m1  \33[0m\n",
+     16, 4, "deadbeefcafe01"},
+    {"xxd -e", "00000000: 64616564 66656562 65666163     3130  deadbeefcafe01\n", 16, 4, "deadbeefcafe01"},
+    {"16 digit offsets",
+     "0000000000000000  64 65 61 64 62 65 65 66  63 61 66 65 30 31 32 33  deadbeefcafe0123\n"
+     "0000000000000010  34 35 36 37 38 39 61 62  63 64 65 66 67 68 69 6a  456789abcdefghij\n"
+     "0000000000000020  6b 6c                                             kl              \n",
+     16, 0, "deadbeefcafe0123456789abcdefghijkl"},
+    {"16 digit offsets, fold",
+     "0000000000000000  61 61 61 61 61 61 61 61  61 61 61 61 61 61 61 61  aaaaaaaaaaaaaaaa\n"
+     "*\n"
+     "0000000000000030  62 62                                             bb              \n",
+     16, 0, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaabb"},
+    {"be, partial line", "00000000  64 65 61 64 62 65 65 66                           deadbeef        \n", 16, 0,
+     "deadbeef"},
+};
+
+bool run(const reverse_case &c) {
+  auto in = tmpfile();
+  auto out = tmpfile();
+  if (in == nullptr || out == nullptr) {
+    bela::FPrintF(stderr, L"tmpfile failed\n");
+    return false;
+  }
+  auto closer = bela::finally([&] {
+    fclose(in);
+    fclose(out);
+  });
+  fwrite(c.dump.data(), 1, c.dump.size(), in);
+  rewind(in);
+  bela::error_code ec;
+  if (!hastyhex::Reverse(in, out, c.width, c.swap, ec)) {
+    bela::FPrintF(stderr, L"%s: %s\n", c.name, ec.message);
+    return false;
+  }
+  char got[256];
+  rewind(out);
+  auto n = fread(got, 1, sizeof(got), out);
+  if (std::string_view(got, n) != c.want) {
+    bela::FPrintF(stderr, L"%s: got %d bytes '%s', want '%s'\n", c.name, n, std::string_view(got, n), c.want);
+    return false;
+  }
+  return true;
+}
+
+int wmain() {
+  int status = 0;
+  for (const auto &c : cases) {
+    if (!run(c)) {
+      status = 1;
+    }
+  }
+  bela::FPrintF(stdout, L"%d cases, %s\n", std::size(cases), status == 0 ? L"ok" : L"failed");
+  return status;
+}